@@ -22,6 +22,20 @@
 /* how long to show notifications */
 #define NOTIFICATION_TIMEOUT	10000
 
+/* size of netlink socket receive buffer, increase if events are dropped
+ * (the kernel caps this at net.core.rmem_max), option -r overrides */
+#define NETLINK_RCVBUF	(1024 * 1024)
+
+/* link attributes to watch for changes, combine any of:
+ * LINK_WATCH_MTU, LINK_WATCH_MASTER, LINK_WATCH_OPERSTATE, LINK_WATCH_LLADDR
+ * operational state mostly follows up/down, so it is not watched by default */
+#define LINK_WATCH	(LINK_WATCH_MTU | LINK_WATCH_MASTER | LINK_WATCH_LLADDR)
+
+/* checkpoint file in $XDG_RUNTIME_DIR, used to restore state on restart,
+ * and interval (in seconds) to write it, 0 writes on exit only */
+#define CHECKPOINT_FILE		"netlink-notify.state"
+#define CHECKPOINT_INTERVAL	60
+
 /* define icons */
 #define ICON_NETWORK_ADDRESS	"netlink-notify-address"
 #define ICON_NETWORK_UP		"netlink-notify-up"
@@ -32,6 +46,11 @@
 #define TEXT_TOPIC	"Netlink Notification"
 #define TEXT_NEWLINK	"Interface <b>%s</b> is <b>%s</b>."
 #define TEXT_WIRELESS	"Interface <b>%s</b> is <b>%s</b> on <b>%s</b>."
+#define TEXT_MTU	"Interface <b>%s</b> has new MTU <b>%u</b>."
+#define TEXT_MASTER	"Interface <b>%s</b> joined <b>%s</b>."
+#define TEXT_NOMASTER	"Interface <b>%s</b> left <b>%s</b>."
+#define TEXT_OPERSTATE	"Interface <b>%s</b> is operationally <b>%s</b>."
+#define TEXT_LLADDR	"Interface <b>%s</b> has new hardware address <b>%s</b>."
 #define TEXT_NEWADDR	"Interface <b>%s</b> has new %s address\n<b>%s</b>/%d."
 #define TEXT_DELLINK	"Interface <b>%s</b> has gone away."
 
@@ -18,110 +18,225 @@
 
 #include "netlink-notify.h"
 
-const static char optstring[] = "ht:vV";
+const static char optstring[] = "hr:t:vV";
 const static struct option options_long[] = {
 	/* name		has_arg			flag	val */
 	{ "help",	no_argument,		NULL,	'h' },
+	{ "rcvbuf",	required_argument,	NULL,	'r' },
 	{ "timeout",	required_argument,	NULL,	't' },
 	{ "verbose",	no_argument,		NULL,	'v' },
 	{ "version",	no_argument,		NULL,	'V' },
 	{ 0, 0, 0, 0 }
 };
 
+const static char *operstates[] = {
+	[IF_OPER_UNKNOWN]		= "unknown",
+	[IF_OPER_NOTPRESENT]		= "not present",
+	[IF_OPER_DOWN]			= "down",
+	[IF_OPER_LOWERLAYERDOWN]	= "lower layer down",
+	[IF_OPER_TESTING]		= "testing",
+	[IF_OPER_DORMANT]		= "dormant",
+	[IF_OPER_UP]			= "up",
+};
+
 char *program;
 unsigned int maxinterface = 0;
 struct ifs * ifs = NULL;
+struct addresses_seen * ifs_addresses = NULL;
+struct ifs_cold * ifs_cold = NULL;
 uint8_t verbose = 0;
 uint8_t doexit = 0;
+uint8_t docheckpoint = 0;
+uint8_t doresync = 0;
+uint8_t resync = RESYNC_NONE;
+uint8_t resync_quiet = 0;
+struct addresses_seen * resync_addresses = NULL;
+unsigned int resync_max = 0;
+unsigned int resync_watch = LINK_WATCH;
+char *checkpoint = NULL;
+unsigned long events_dropped = 0;
 unsigned int notification_timeout = NOTIFICATION_TIMEOUT;
+int netlink_rcvbuf = NETLINK_RCVBUF;
 
-/*** free_addresses ***/
-void free_addresses(struct addresses_seen *addresses_seen) {
-	struct addresses_seen *next = NULL;
+/*** get_address ***/
+struct address * get_address(struct addresses_seen *addresses_seen, const unsigned int i) {
+	if (i < ADDRESSES_INLINE)
+		return &addresses_seen->local[i];
 
-	/* free everything else */
-	while (addresses_seen != NULL) {
-		next = addresses_seen->next;
-		free(addresses_seen);
-		addresses_seen = next;
-	}
+	return &addresses_seen->overflow[i - ADDRESSES_INLINE];
 }
 
-/*** add_address ***/
-struct addresses_seen * add_address(struct addresses_seen *addresses_seen, const char *address, const unsigned char prefix) {
-	struct addresses_seen *first = addresses_seen;
+/*** fill_address ***/
+void fill_address(struct address *address, const struct ifaddrmsg *ifa, struct rtattr *rth) {
+	memset(address, 0, sizeof(struct address));
+	address->family = ifa->ifa_family;
+	address->prefix = ifa->ifa_prefixlen;
+	memcpy(address->address, RTA_DATA (rth),
+		RTA_PAYLOAD (rth) < sizeof(address->address) ? RTA_PAYLOAD (rth) : sizeof(address->address));
+}
 
-	if (addresses_seen == NULL) {
-		addresses_seen = malloc(sizeof(struct addresses_seen));
-		strcpy(addresses_seen->address, address);
-		addresses_seen->prefix = prefix;
-		addresses_seen->next = NULL;
-		return addresses_seen;
-	}
+/*** same_address ***/
+int same_address(const struct address *a, const struct address *b) {
+	/* the mark is not part of the address */
+	return a->family == b->family && a->prefix == b->prefix &&
+		memcmp(a->address, b->address, sizeof(a->address)) == 0;
+}
 
-	while (addresses_seen->next != NULL) {
-		/* just find the last one */
-		addresses_seen = addresses_seen->next;
-	}
+/*** free_addresses ***/
+void free_addresses(struct addresses_seen *addresses_seen) {
+	free(addresses_seen->overflow);
+	memset(addresses_seen, 0, sizeof(struct addresses_seen));
+}
 
-	addresses_seen->next = malloc(sizeof(struct addresses_seen));
-	addresses_seen = addresses_seen->next;
-	strcpy(addresses_seen->address, address);
-	addresses_seen->prefix = prefix;
-	addresses_seen->next = NULL;
+/*** add_address ***/
+void add_address(struct addresses_seen *addresses_seen, const struct address *address) {
+	/* grow the overflow storage if inline storage is exhausted */
+	if (addresses_seen->count >= ADDRESSES_INLINE + addresses_seen->size) {
+		addresses_seen->size = addresses_seen->size ? addresses_seen->size * 2 : ADDRESSES_INLINE;
+		addresses_seen->overflow = realloc(addresses_seen->overflow,
+			addresses_seen->size * sizeof(struct address));
+	}
 
-	return first;
+	memcpy(get_address(addresses_seen, addresses_seen->count), address, sizeof(struct address));
+	addresses_seen->count++;
 }
 
 /*** remove_address ***/
-struct addresses_seen * remove_address(struct addresses_seen *addresses_seen, const char *address, const unsigned char prefix) {
-	struct addresses_seen *first = addresses_seen, *last = NULL;
-
-	/* no addresses, just return NULL */
-	if (addresses_seen == NULL)
-		return NULL;
-
-	/* first address matches, return new start */
-	if (strcmp(addresses_seen->address, address) == 0 && addresses_seen->prefix == prefix) {
-		first = addresses_seen->next;
-		free(addresses_seen);
-		return first;
-	}
-
-	/* find the address and remove it */
-	while (addresses_seen != NULL) {
-		if (strcmp(addresses_seen->address, address) == 0 && addresses_seen->prefix == prefix) {
-			last->next = addresses_seen->next;
-			free(addresses_seen);
+void remove_address(struct addresses_seen *addresses_seen, const struct address *address) {
+	unsigned int i;
+
+	/* find the address and replace it with the last one */
+	for (i = 0; i < addresses_seen->count; i++) {
+		if (same_address(get_address(addresses_seen, i), address)) {
+			addresses_seen->count--;
+			memcpy(get_address(addresses_seen, i),
+				get_address(addresses_seen, addresses_seen->count), sizeof(struct address));
 			break;
 		}
-		last = addresses_seen;
-		addresses_seen = addresses_seen->next;
 	}
-	return first;
+}
+
+/*** mark_addresses ***/
+void mark_addresses(struct addresses_seen *addresses_seen) {
+	unsigned int i;
+
+	/* the kernel keeps (IPv4) addresses when the link goes down,
+	 * they are notified again only if reported by a new event */
+	for (i = 0; i < addresses_seen->count; i++)
+		get_address(addresses_seen, i)->stale = 1;
 }
 
 /*** match_address ***/
-int match_address(struct addresses_seen *addresses_seen, const char *address, const unsigned char prefix) {
-	while (addresses_seen != NULL) {
-		if (strcmp(addresses_seen->address, address) == 0 && addresses_seen->prefix == prefix) {
-			return 1;
-		}
-		addresses_seen = addresses_seen->next;
+struct address * match_address(struct addresses_seen *addresses_seen, const struct address *address) {
+	unsigned int i;
+
+	for (i = 0; i < addresses_seen->count; i++) {
+		if (same_address(get_address(addresses_seen, i), address))
+			return get_address(addresses_seen, i);
 	}
-	return 0;
+	return NULL;
 }
 
 /*** list_addresses ***/
 void list_addresses(struct addresses_seen *addresses_seen, const char *interface) {
+	unsigned int i;
+	struct address *address;
+	char buf[INET6_ADDRSTRLEN];
+
 	printf("%s: Addresses seen for interface %s:", program, interface);
-	while (addresses_seen != NULL) {
-		printf(" %s/%d", addresses_seen->address, addresses_seen->prefix);
-		addresses_seen = addresses_seen->next;
+	for (i = 0; i < addresses_seen->count; i++) {
+		address = get_address(addresses_seen, i);
+		inet_ntop(address->family, address->address, buf, sizeof(buf));
+		printf(" %s/%d", buf, address->prefix);
 	}
 	putchar('\n');
 }
 
+/*** hash_data ***/
+uint32_t hash_data(const unsigned char *data, const unsigned int len) {
+	uint32_t hash = 2166136261u;
+	unsigned int i;
+
+	/* FNV-1a */
+	for (i = 0; i < len; i++)
+		hash = (hash ^ data[i]) * 16777619u;
+
+	return hash;
+}
+
+/*** get_link_attrs ***/
+void get_link_attrs(struct ifinfomsg *ifi, int rtl, struct link_attrs *attrs,
+		struct rtattr **lladdr, struct rtattr **ifname) {
+	struct rtattr *rth;
+
+	memset(attrs, 0, sizeof(struct link_attrs));
+	*lladdr = NULL;
+	*ifname = NULL;
+
+	/* pick the watched attributes only, everything else
+	 * (mostly statistics) does not make it into the fingerprint */
+	for (rth = IFLA_RTA (ifi); RTA_OK (rth, rtl); rth = RTA_NEXT (rth, rtl)) {
+		switch (rth->rta_type) {
+			case IFLA_MTU:
+				if (LINK_WATCH & LINK_WATCH_MTU)
+					attrs->mtu = *(uint32_t *) RTA_DATA (rth);
+				break;
+			case IFLA_MASTER:
+				if (LINK_WATCH & LINK_WATCH_MASTER)
+					attrs->master = *(uint32_t *) RTA_DATA (rth);
+				break;
+			case IFLA_OPERSTATE:
+				if (LINK_WATCH & LINK_WATCH_OPERSTATE)
+					attrs->operstate = *(uint8_t *) RTA_DATA (rth);
+				break;
+			case IFLA_ADDRESS:
+				if (LINK_WATCH & LINK_WATCH_LLADDR) {
+					attrs->lladdr = hash_data(RTA_DATA (rth), RTA_PAYLOAD (rth));
+					*lladdr = rth;
+				}
+				break;
+			case IFLA_IFNAME:
+				attrs->ifname = hash_data(RTA_DATA (rth), RTA_PAYLOAD (rth));
+				*ifname = rth;
+				break;
+		}
+	}
+}
+
+/*** diff_link_attrs ***/
+unsigned int diff_link_attrs(const struct link_attrs *old, const struct link_attrs *new) {
+	unsigned int changed = 0;
+
+	/* nothing changed, this is the common case */
+	if (memcmp(old, new, sizeof(struct link_attrs)) == 0)
+		return 0;
+
+	if (old->mtu != new->mtu)
+		changed |= LINK_WATCH_MTU;
+	if (old->master != new->master)
+		changed |= LINK_WATCH_MASTER;
+	if (old->operstate != new->operstate)
+		changed |= LINK_WATCH_OPERSTATE;
+	if (old->lladdr != new->lladdr)
+		changed |= LINK_WATCH_LLADDR;
+	if (old->ifname != new->ifname)
+		changed |= LINK_IFNAME;
+
+	return changed;
+}
+
+/*** get_ifname ***/
+void get_ifname(const unsigned int index, char *name) {
+	/* the interface may be gone, fall back to what we know */
+	if (if_indextoname(index, name) != NULL)
+		return;
+
+	if (index <= maxinterface)
+		strcpy(name, ifs_cold[index].name);
+	else
+		strcpy(name, "(unknown)");
+}
+
 /*** get_ssid ***/
 void get_ssid(const char *interface, char *essid) {
 	int sockfd;
@@ -140,6 +255,23 @@ void get_ssid(const char *interface, char *essid) {
 	close(sockfd);
 }
 
+/*** new_notification ***/
+NotifyNotification * new_notification(void) {
+	NotifyNotification *notification;
+
+	notification =
+#		if NOTIFY_CHECK_VERSION(0, 7, 0)
+		notify_notification_new(TEXT_TOPIC, NULL, NULL);
+#		else
+		notify_notification_new(TEXT_TOPIC, NULL, NULL, NULL);
+#		endif
+	notify_notification_set_category(notification, PROGNAME);
+	notify_notification_set_urgency(notification, NOTIFY_URGENCY_NORMAL);
+	notify_notification_set_timeout(notification, notification_timeout);
+
+	return notification;
+}
+
 /*** newstr_link ***/
 char * newstr_link(const char *interface, const unsigned int flags) {
 	char *notifystr, *e_interface = NULL, *e_essid = NULL;
@@ -167,6 +299,71 @@ char * newstr_link(const char *interface, const unsigned int flags) {
 	return notifystr;
 }
 
+/*** newstr_attrs ***/
+char * newstr_attrs(const char *interface, const unsigned int changed,
+		const struct link_attrs *old, const struct link_attrs *new, struct rtattr *lladdr) {
+	char *notifystr, *e_interface = NULL, *e_old_master = NULL, *e_new_master = NULL;
+	char master[IF_NAMESIZE], hwaddr[3 * 32] = "";
+	const char *operstate = "unknown";
+	unsigned char *data;
+	unsigned int i;
+
+	e_interface = g_markup_escape_text(interface, -1);
+
+	if (changed & LINK_WATCH_MASTER) {
+		if (old->master > 0) {
+			get_ifname(old->master, master);
+			e_old_master = g_markup_escape_text(master, -1);
+		}
+		if (new->master > 0) {
+			get_ifname(new->master, master);
+			e_new_master = g_markup_escape_text(master, -1);
+		}
+	}
+
+	if ((changed & LINK_WATCH_OPERSTATE) &&
+			new->operstate < sizeof(operstates) / sizeof(operstates[0]))
+		operstate = operstates[new->operstate];
+
+	if ((changed & LINK_WATCH_LLADDR) && lladdr != NULL) {
+		data = RTA_DATA (lladdr);
+		for (i = 0; i < RTA_PAYLOAD (lladdr) && i < 32; i++)
+			sprintf(hwaddr + (i ? 3 * i - 1 : 0), i ? ":%02x" : "%02x", data[i]);
+	}
+
+	notifystr = malloc(sizeof(TEXT_MTU) + sizeof(TEXT_MASTER) + sizeof(TEXT_NOMASTER)
+		+ sizeof(TEXT_OPERSTATE) + sizeof(TEXT_LLADDR) + 5 * strlen(e_interface) + 10
+		+ (e_old_master ? strlen(e_old_master) : 0) + (e_new_master ? strlen(e_new_master) : 0)
+		+ strlen(operstate) + strlen(hwaddr));
+	*notifystr = '\0';
+
+	if (changed & LINK_WATCH_MTU)
+		sprintf(notifystr + strlen(notifystr), TEXT_MTU "\n", e_interface, new->mtu);
+	if (e_old_master != NULL)
+		sprintf(notifystr + strlen(notifystr), TEXT_NOMASTER "\n", e_interface, e_old_master);
+	if (e_new_master != NULL)
+		sprintf(notifystr + strlen(notifystr), TEXT_MASTER "\n", e_interface, e_new_master);
+	if (changed & LINK_WATCH_OPERSTATE)
+		sprintf(notifystr + strlen(notifystr), TEXT_OPERSTATE "\n", e_interface, operstate);
+	/* the hardware address may have been removed, nothing to show then */
+	if ((changed & LINK_WATCH_LLADDR) && *hwaddr != '\0')
+		sprintf(notifystr + strlen(notifystr), TEXT_LLADDR "\n", e_interface, hwaddr);
+
+	/* strip the trailing newline */
+	if (*notifystr != '\0') {
+		notifystr[strlen(notifystr) - 1] = '\0';
+	} else {
+		free(notifystr);
+		notifystr = NULL;
+	}
+
+	free(e_interface);
+	free(e_old_master);
+	free(e_new_master);
+
+	return notifystr;
+}
+
 /*** newstr_addr ***/
 char * newstr_addr(const char *interface, const unsigned char family, const char *ipaddr, const unsigned char prefix) {
 	char *notifystr, *e_interface = NULL;
@@ -195,6 +392,303 @@ char * newstr_away(const char *interface) {
 	return notifystr;
 }
 
+/*** init_interfaces ***/
+void init_interfaces(const unsigned int index, const uint8_t lookup) {
+	if (maxinterface >= index)
+		return;
+
+	ifs = realloc(ifs, (index + 1) * sizeof(struct ifs));
+	ifs_addresses = realloc(ifs_addresses, (index + 1) * sizeof(struct addresses_seen));
+	ifs_cold = realloc(ifs_cold, (index + 1) * sizeof(struct ifs_cold));
+	while(maxinterface < index) {
+		maxinterface++;
+
+		memset(&ifs[maxinterface], 0, sizeof(struct ifs));
+		memset(&ifs_addresses[maxinterface], 0, sizeof(struct addresses_seen));
+		memset(&ifs_cold[maxinterface], 0, sizeof(struct ifs_cold));
+
+		/* notification is created when first needed */
+		ifs[maxinterface].state = -1;
+
+		/* names restored from checkpoint are checked by the link dump,
+		 * looking up every single interface would delay startup */
+		if (lookup == 0)
+			continue;
+
+		if (verbose > 0)
+			printf("%s: Initializing interface %d: ", program, maxinterface);
+
+		/* get interface name and store it
+		 * in case the interface does no longer exist this may fail,
+		 * use static string '(unknown)' instead */
+		if (if_indextoname(maxinterface, ifs_cold[maxinterface].name) == NULL)
+			strcpy(ifs_cold[maxinterface].name, "(unknown)");
+
+		if (verbose > 0)
+			printf("%s\n", ifs_cold[maxinterface].name);
+	}
+}
+
+/*** write_checkpoint ***/
+int write_checkpoint(const char *path) {
+	int failed, rc = EXIT_FAILURE;
+	char *tmp;
+	FILE *file;
+	struct checkpoint_header header;
+	struct checkpoint_ifs record;
+	unsigned int i, j;
+
+	tmp = malloc(strlen(path) + 5);
+	sprintf(tmp, "%s.tmp", path);
+
+	if (maxinterface > CHECKPOINT_MAXINTERFACE) {
+		fprintf(stderr, "%s: Too many interfaces for checkpoint.\n", program);
+		goto out;
+	}
+
+	if ((file = fopen(tmp, "w")) == NULL) {
+		fprintf(stderr, "%s: Failed to open checkpoint %s: %s\n", program, tmp, strerror(errno));
+		goto out;
+	}
+
+	memset(&header, 0, sizeof(struct checkpoint_header));
+	header.magic = CHECKPOINT_MAGIC;
+	header.ifs_size = sizeof(struct checkpoint_ifs);
+	header.address_size = sizeof(struct address);
+	header.maxinterface = maxinterface;
+	header.link_watch = LINK_WATCH;
+	fwrite(&header, sizeof(struct checkpoint_header), 1, file);
+
+	for (i = 1; i <= maxinterface; i++) {
+		memset(&record, 0, sizeof(struct checkpoint_ifs));
+		memcpy(record.name, ifs_cold[i].name, IF_NAMESIZE);
+		record.state = ifs[i].state;
+		record.deleted = ifs[i].deleted;
+		record.addresses = ifs_addresses[i].count;
+		record.attrs = ifs[i].attrs;
+		fwrite(&record, sizeof(struct checkpoint_ifs), 1, file);
+
+		for (j = 0; j < ifs_addresses[i].count; j++)
+			fwrite(get_address(&ifs_addresses[i], j), sizeof(struct address), 1, file);
+	}
+
+	/* write to temporary file and rename, so the checkpoint is never partial */
+	failed = ferror(file);
+	if (fclose(file) != 0 || failed != 0 || rename(tmp, path) < 0) {
+		fprintf(stderr, "%s: Failed to write checkpoint %s: %s\n", program, path, strerror(errno));
+		unlink(tmp);
+		goto out;
+	}
+
+	if (verbose > 1)
+		printf("%s: Wrote checkpoint with %d interfaces to %s.\n", program, maxinterface, path);
+
+	rc = EXIT_SUCCESS;
+
+out:
+	free(tmp);
+
+	return rc;
+}
+
+/*** read_checkpoint ***/
+int read_checkpoint(const char *path) {
+	int fd, rc = EXIT_FAILURE;
+	struct stat st;
+	unsigned char *map;
+	size_t offset;
+	struct checkpoint_header header;
+	struct checkpoint_ifs record;
+	unsigned int i, j;
+
+	if ((fd = open(path, O_RDONLY)) < 0)
+		return rc;
+
+	if (fstat(fd, &st) < 0 || st.st_size < sizeof(struct checkpoint_header))
+		goto out10;
+
+	if ((map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+		goto out10;
+
+	memcpy(&header, map, sizeof(struct checkpoint_header));
+	if (header.magic != CHECKPOINT_MAGIC ||
+			header.ifs_size != sizeof(struct checkpoint_ifs) ||
+			header.address_size != sizeof(struct address) ||
+			header.maxinterface > CHECKPOINT_MAXINTERFACE ||
+			sizeof(struct checkpoint_header) + (size_t) header.maxinterface
+				* sizeof(struct checkpoint_ifs) > st.st_size)
+		goto invalid;
+
+	/* validate all records before anything is allocated or restored,
+	 * records are packed, so copy to get aligned access */
+	offset = sizeof(struct checkpoint_header);
+	for (i = 1; i <= header.maxinterface; i++) {
+		if (st.st_size - offset < sizeof(struct checkpoint_ifs))
+			goto invalid;
+		memcpy(&record, map + offset, sizeof(struct checkpoint_ifs));
+		offset += sizeof(struct checkpoint_ifs);
+
+		if (record.addresses > (st.st_size - offset) / sizeof(struct address))
+			goto invalid;
+		offset += record.addresses * sizeof(struct address);
+	}
+
+	if (offset != st.st_size)
+		goto invalid;
+
+	init_interfaces(header.maxinterface, 0);
+
+	/* whether an index still refers to the same interface is checked
+	 * against the name by the link dump, see msg_handler() */
+	offset = sizeof(struct checkpoint_header);
+	for (i = 1; i <= header.maxinterface; i++) {
+		memcpy(&record, map + offset, sizeof(struct checkpoint_ifs));
+		offset += sizeof(struct checkpoint_ifs);
+
+		ifs[i].state = record.state;
+		ifs[i].deleted = record.deleted;
+		ifs[i].attrs = record.attrs;
+		memcpy(ifs_cold[i].name, record.name, IF_NAMESIZE);
+		ifs_cold[i].name[IF_NAMESIZE - 1] = '\0';
+
+		for (j = 0; j < record.addresses; j++)
+			add_address(&ifs_addresses[i],
+				(struct address *) (map + offset + j * sizeof(struct address)));
+
+		offset += record.addresses * sizeof(struct address);
+	}
+
+	/* attributes not watched before were not saved, the link dump
+	 * seeds them without notification */
+	resync_watch = header.link_watch & LINK_WATCH;
+
+	if (verbose > 0)
+		printf("%s: Restored %d interfaces from checkpoint %s.\n", program, header.maxinterface, path);
+
+	rc = EXIT_SUCCESS;
+	goto out20;
+
+invalid:
+	fprintf(stderr, "%s: Ignoring invalid checkpoint %s.\n", program, path);
+
+out20:
+	munmap(map, st.st_size);
+
+out10:
+	close(fd);
+
+	return rc;
+}
+
+/*** request_dump ***/
+int request_dump(int sock, const unsigned short type) {
+	struct sockaddr_nl addr;
+	struct {
+		struct nlmsghdr nlh;
+		union {
+			struct ifinfomsg ifi;
+			struct ifaddrmsg ifa;
+		};
+	} req;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+
+	/* family is AF_UNSPEC for either message */
+	memset(&req, 0, sizeof(req));
+	req.nlh.nlmsg_len = type == RTM_GETADDR ?
+		NLMSG_LENGTH(sizeof(struct ifaddrmsg)) : NLMSG_LENGTH(sizeof(struct ifinfomsg));
+	req.nlh.nlmsg_type = type;
+	req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+
+	return sendto(sock, &req, req.nlh.nlmsg_len, 0, (struct sockaddr *) &addr, sizeof(addr));
+}
+
+/*** start_resync ***/
+int start_resync(int sock, const uint8_t quiet) {
+	unsigned int i;
+
+	/* at startup interfaces not known before are recorded quietly,
+	 * after lost events they are what we missed and are notified */
+	resync_quiet = quiet;
+
+	for (i = 1; i <= maxinterface; i++)
+		ifs[i].seen = 0;
+
+	if (request_dump(sock, RTM_GETLINK) < 0) {
+		fprintf(stderr, "%s: Failed to request link dump.\n", program);
+		return EXIT_FAILURE;
+	}
+
+	if (verbose > 0)
+		printf("%s: Resyncing with kernel state...\n", program);
+
+	resync = RESYNC_LINK;
+
+	return EXIT_SUCCESS;
+}
+
+/*** finish_resync ***/
+int finish_resync(int sock) {
+	unsigned int i;
+	struct {
+		struct nlmsghdr nlh;
+		struct ifinfomsg ifi;
+	} dellink;
+
+	switch (resync) {
+		case RESYNC_LINK:
+			/* from now on all watched attributes are known */
+			resync_watch = LINK_WATCH;
+
+			/* interfaces missing from the dump have gone away,
+			 * handle them as if RTM_DELLINK was received */
+			for (i = 1; i <= maxinterface; i++) {
+				if (ifs[i].deleted == 1 || ifs[i].state < 0 || ifs[i].seen > 0)
+					continue;
+
+				memset(&dellink, 0, sizeof(dellink));
+				dellink.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+				dellink.nlh.nlmsg_type = RTM_DELLINK;
+				dellink.ifi.ifi_index = i;
+				msg_handler(NULL, &dellink.nlh);
+			}
+
+			/* addresses from the dump are collected here and
+			 * replace what we have when the dump is finished */
+			resync_max = maxinterface;
+			resync_addresses = calloc(resync_max + 1, sizeof(struct addresses_seen));
+
+			if (request_dump(sock, RTM_GETADDR) < 0) {
+				fprintf(stderr, "%s: Failed to request address dump.\n", program);
+				free(resync_addresses);
+				resync_addresses = NULL;
+				resync = RESYNC_NONE;
+				return EXIT_FAILURE;
+			}
+
+			resync = RESYNC_ADDR;
+			break;
+
+		case RESYNC_ADDR:
+			/* addresses missing from the dump are gone */
+			for (i = 1; i <= resync_max; i++) {
+				free_addresses(&ifs_addresses[i]);
+				ifs_addresses[i] = resync_addresses[i];
+			}
+
+			free(resync_addresses);
+			resync_addresses = NULL;
+			resync = RESYNC_NONE;
+
+			if (verbose > 0)
+				printf("%s: Resync finished.\n", program);
+			break;
+	}
+
+	return EXIT_SUCCESS;
+}
+
 /*** open_netlink ***/
 int open_netlink (void) {
 	int sock;
@@ -209,6 +703,13 @@ int open_netlink (void) {
 	addr.nl_pid = getpid();
 	addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
 
+	/* a burst of events (think of thousands of interfaces appearing at
+	 * once) can overflow the default receive buffer, so enlarge it -
+	 * exceeding net.core.rmem_max needs CAP_NET_ADMIN */
+	if (setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE, &netlink_rcvbuf, sizeof(netlink_rcvbuf)) < 0 &&
+			setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &netlink_rcvbuf, sizeof(netlink_rcvbuf)) < 0)
+		fprintf (stderr, "open_netlink: Failed to set receive buffer size.\n");
+
 	if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) < 0)
 		return -1;
 
@@ -218,7 +719,9 @@ int open_netlink (void) {
 /*** read_event ***/
 int read_event (int sockint) {
 	int status, rc = EXIT_FAILURE;
-	char buf[4096];
+	/* the kernel sizes dump replies to what we read (up to 32 KiB),
+	 * larger reads mean less round trips for big dumps */
+	static char buf[32768];
 	struct iovec iov = { buf, sizeof buf };
 	struct sockaddr_nl snl;
 	struct msghdr msg = { (void *) &snl, sizeof snl, &iov, 1, NULL, 0, 0 };
@@ -231,6 +734,17 @@ int read_event (int sockint) {
 			goto out;
 		}
 
+		/* The receive buffer overflowed and events were lost, this is
+		 * not fatal - count and resync with the kernel */
+		if (errno == ENOBUFS) {
+			events_dropped++;
+			doresync++;
+			fprintf (stderr, "read_netlink: Receive buffer overflow, events dropped (%lu times so far), resyncing\n",
+					events_dropped);
+			rc = EXIT_SUCCESS;
+			goto out;
+		}
+
 		/* Anything else is an error */
 		fprintf (stderr, "read_netlink: Error recvmsg: %d\n", status);
 		goto out;
@@ -241,8 +755,10 @@ int read_event (int sockint) {
 
 	/* We need to handle more than one message per 'recvmsg' */
 	for (h = (struct nlmsghdr *) buf; NLMSG_OK (h, (unsigned int) status); h = NLMSG_NEXT (h, status)) {
-		/* Finish reading */
+		/* Finish reading, a dump is complete */
 		if (h->nlmsg_type == NLMSG_DONE) {
+			if (resync != RESYNC_NONE)
+				finish_resync(sockint);
 			rc = EXIT_SUCCESS;
 			goto out;
 		}
@@ -269,52 +785,39 @@ out:
 /*** msg_handler ***/
 int msg_handler (struct sockaddr_nl *nl, struct nlmsghdr *msg) {
 	int rc = EXIT_FAILURE;
-	char *notifystr = NULL;
+	char *notifystr = NULL, *attrstr = NULL;
 	GError *error = NULL;
 	struct ifaddrmsg *ifa;
 	struct ifinfomsg *ifi;
 	struct rtattr *rth;
 	int rtl;
 	char buf[INET6_ADDRSTRLEN];
+	struct address address, *known, *collected;
+	uint8_t notify = 0;
+	struct link_attrs attrs;
+	struct rtattr *lladdr, *ifname;
+	unsigned int changed;
+	struct ifs *interface;
+	struct addresses_seen *addresses_seen;
+	struct ifs_cold *interface_cold;
 	NotifyNotification *addr_notification = NULL, *notification = NULL;
 	char *icon = NULL;
 
 	ifa = (struct ifaddrmsg *) NLMSG_DATA (msg);
 	ifi = (struct ifinfomsg *) NLMSG_DATA (msg);
 
+	/* bridge ports get link messages of their own (family AF_BRIDGE),
+	 * a port leaving its bridge sends RTM_DELLINK - membership is
+	 * reported by IFLA_MASTER in the regular messages */
+	if ((msg->nlmsg_type == RTM_NEWLINK || msg->nlmsg_type == RTM_DELLINK) &&
+			ifi->ifi_family == AF_BRIDGE) {
+		rc = EXIT_SUCCESS;
+		goto out;
+	}
+
 	/* make sure we have alloced memory for NotifyNotification and addresses_seen struct array */
 	if (maxinterface < ifi->ifi_index) {
-		ifs = realloc(ifs, (ifi->ifi_index + 1) * sizeof(struct ifs));
-		while(maxinterface < ifi->ifi_index) {
-			maxinterface++;
-
-			if (verbose > 0)
-				printf("%s: Initializing interface %d: ", program, maxinterface);
-
-			/* get interface name and store it
-			 * in case the interface does no longer exist this may fail,
-			 * use static string '(unknown)' instead */
-			if (if_indextoname(maxinterface, ifs[maxinterface].name) == NULL)
-				strcpy(ifs[maxinterface].name, "(unknown)");
-
-			if (verbose > 0)
-				printf("%s\n", ifs[maxinterface].name);
-
-			ifs[maxinterface].state = -1;
-			ifs[maxinterface].deleted = 0;
-
-			ifs[maxinterface].notification =
-#				if NOTIFY_CHECK_VERSION(0, 7, 0)
-				notify_notification_new(TEXT_TOPIC, NULL, NULL);
-#				else
-				notify_notification_new(TEXT_TOPIC, NULL, NULL, NULL);
-#				endif
-			notify_notification_set_category(ifs[maxinterface].notification, PROGNAME);
-			notify_notification_set_urgency(ifs[maxinterface].notification, NOTIFY_URGENCY_NORMAL);
-			notify_notification_set_timeout(ifs[maxinterface].notification, notification_timeout);
-
-			ifs[maxinterface].addresses_seen = NULL;
-		}
+		init_interfaces(ifi->ifi_index, 1);
 	} else if (ifs[ifi->ifi_index].deleted == 1) {
 		if (verbose > 0)
 			printf("%s: Ignoring event for deleted interface %d.\n", program, ifi->ifi_index);
@@ -322,17 +825,15 @@ int msg_handler (struct sockaddr_nl *nl, struct nlmsghdr *msg) {
 		goto out;
 	}
 
-	/* make notification point to the array element, will be overwritten
-	 * later when needed for address notification */
-	notification = ifs[ifi->ifi_index].notification;
-
-	/* get interface name and store it
-	 * in case the interface does no longer exist this may fail, but it does not overwrite */
-	if_indextoname(ifi->ifi_index, ifs[ifi->ifi_index].name);
+	interface = &ifs[ifi->ifi_index];
+	addresses_seen = &ifs_addresses[ifi->ifi_index];
+	interface_cold = &ifs_cold[ifi->ifi_index];
 
+	/* the interface name is not looked up here, it is taken from
+	 * RTM_NEWLINK messages (see below) which are sent on rename */
 	if (verbose > 1)
 		printf("%s: Event for interface %s (%d): flags = %x, msg type = %d\n",
-			program, ifs[ifi->ifi_index].name, ifi->ifi_index, ifa->ifa_flags, msg->nlmsg_type);
+			program, interface_cold->name, ifi->ifi_index, ifa->ifa_flags, msg->nlmsg_type);
 
 	switch (msg->nlmsg_type) {
 		/* just return for cases we want to ignore
@@ -345,24 +846,48 @@ int msg_handler (struct sockaddr_nl *nl, struct nlmsghdr *msg) {
 				if ((rth->rta_type == IFA_LOCAL /* IPv4 */
 						|| rth->rta_type == IFA_ADDRESS /* IPv6 */)
 						&& ifa->ifa_scope == RT_SCOPE_UNIVERSE /* no IPv6 scope link */) {
-					inet_ntop(ifa->ifa_family, RTA_DATA (rth), buf, sizeof(buf));
-
-					/* check if we already notified about this address */
-					if (match_address(ifs[ifi->ifi_index].addresses_seen, buf, ifa->ifa_prefixlen)) {
-						if (verbose > 0)
-							printf("%s: Address %s/%d already known for %s, ignoring.\n",
-									program, buf, ifa->ifa_prefixlen, ifs[ifi->ifi_index].name);
-						break;
+					fill_address(&address, ifa, rth);
+
+					/* check if we already notified about this address,
+					 * the dump reports what the kernel has - addresses
+					 * known before are not new, even if marked stale */
+					if ((known = match_address(addresses_seen, &address)) == NULL) {
+						add_address(addresses_seen, &address);
+						known = get_address(addresses_seen, addresses_seen->count - 1);
+
+						/* the address dump just records addresses of
+						 * interfaces that were not known before */
+						if (!(msg->nlmsg_flags & NLM_F_MULTI) || interface->seen != SEEN_NEW)
+							notify++;
+					} else if (known->stale > 0 && !(msg->nlmsg_flags & NLM_F_MULTI)) {
+						/* link went down since notified */
+						known->stale = 0;
+						notify++;
+					} else if (verbose > 0) {
+						inet_ntop(ifa->ifa_family, address.address, buf, sizeof(buf));
+						printf("%s: Address %s/%d already known for %s, ignoring.\n",
+								program, buf, ifa->ifa_prefixlen, interface_cold->name);
 					}
 
-					/* add address to struct */
-					ifs[ifi->ifi_index].addresses_seen =
-						add_address(ifs[ifi->ifi_index].addresses_seen, buf, ifa->ifa_prefixlen);
 					if (verbose > 1)
-						list_addresses(ifs[ifi->ifi_index].addresses_seen, ifs[ifi->ifi_index].name);
+						list_addresses(addresses_seen, interface_cold->name);
+
+					/* collect addresses while the address dump is running,
+					 * with their mark */
+					if (resync == RESYNC_ADDR && ifi->ifi_index <= resync_max) {
+						if ((collected = match_address(&resync_addresses[ifi->ifi_index], &address)) == NULL)
+							add_address(&resync_addresses[ifi->ifi_index], known);
+						else
+							collected->stale = known->stale;
+					}
+
+					if (notify == 0)
+						break;
+
+					inet_ntop(ifa->ifa_family, address.address, buf, sizeof(buf));
 
 					/* display notification */
-					notifystr = newstr_addr(ifs[ifi->ifi_index].name,
+					notifystr = newstr_addr(interface_cold->name,
 						ifa->ifa_family, buf, ifa->ifa_prefixlen);
 
 					/* we are done, no need to run more loops */
@@ -377,15 +902,7 @@ int msg_handler (struct sockaddr_nl *nl, struct nlmsghdr *msg) {
 			}
 
 			/* do we want new notification, not update the notification about link status */
-			addr_notification =
-#				if NOTIFY_CHECK_VERSION(0, 7, 0)
-				notify_notification_new(TEXT_TOPIC, NULL, NULL);
-#				else
-				notify_notification_new(TEXT_TOPIC, NULL, NULL, NULL);
-#				endif
-			notify_notification_set_category(addr_notification, PROGNAME);
-			notify_notification_set_urgency(addr_notification, NOTIFY_URGENCY_NORMAL);
-			notify_notification_set_timeout(addr_notification, notification_timeout);
+			addr_notification = new_notification();
 
 			notification = addr_notification;
 
@@ -400,11 +917,12 @@ int msg_handler (struct sockaddr_nl *nl, struct nlmsghdr *msg) {
 				if ((rth->rta_type == IFA_LOCAL /* IPv4 */
 						|| rth->rta_type == IFA_ADDRESS /* IPv6 */)
 						&& ifa->ifa_scope == RT_SCOPE_UNIVERSE /* no IPv6 scope link */) {
-					inet_ntop(ifa->ifa_family, RTA_DATA (rth), buf, sizeof(buf));
-					ifs[ifi->ifi_index].addresses_seen =
-						remove_address(ifs[ifi->ifi_index].addresses_seen, buf, ifa->ifa_prefixlen);
+					fill_address(&address, ifa, rth);
+					remove_address(addresses_seen, &address);
+					if (resync == RESYNC_ADDR && ifi->ifi_index <= resync_max)
+						remove_address(&resync_addresses[ifi->ifi_index], &address);
 					if (verbose > 1)
-						list_addresses(ifs[ifi->ifi_index].addresses_seen, ifs[ifi->ifi_index].name);
+						list_addresses(addresses_seen, interface_cold->name);
 
 					/* we are done, no need to run more loops */
 					break;
@@ -424,33 +942,93 @@ int msg_handler (struct sockaddr_nl *nl, struct nlmsghdr *msg) {
 			goto out;
 
 		case RTM_NEWLINK:
-			/* ignore if state did not change */
-			if ((ifi->ifi_flags & CHECK_CONNECTED) == ifs[ifi->ifi_index].state) {
-				rc = EXIT_SUCCESS;
-				goto out;
+			/* compare the fingerprint of watched attributes,
+			 * attributes are not reported when the interface is seen first */
+			get_link_attrs(ifi, IFLA_PAYLOAD (msg), &attrs, &lladdr, &ifname);
+
+			/* an index with another name in the link dump is not the
+			 * interface we knew (or it was renamed while we were not
+			 * listening), forget what we had and record it as new */
+			if ((msg->nlmsg_flags & NLM_F_MULTI) && interface->state >= 0 &&
+					interface->attrs.ifname != attrs.ifname) {
+				if (verbose > 0)
+					printf("%s: Interface %d is not what we knew, recording it as new.\n",
+						program, ifi->ifi_index);
+				interface->state = -1;
+				free_addresses(addresses_seen);
 			}
 
-			ifs[ifi->ifi_index].state = ifi->ifi_flags & CHECK_CONNECTED;
-
-			notifystr = newstr_link(ifs[ifi->ifi_index].name, ifi->ifi_flags);
+			changed = interface->state < 0 ? LINK_IFNAME : diff_link_attrs(&interface->attrs, &attrs);
+
+			/* follow renames */
+			if ((changed & LINK_IFNAME) && ifname != NULL)
+				snprintf(interface_cold->name, IF_NAMESIZE, "%.*s",
+					(int) RTA_PAYLOAD (ifname), (char *) RTA_DATA (ifname));
+			changed &= ~LINK_IFNAME;
+			if (resync == RESYNC_LINK)
+				changed &= resync_watch;
+
+			if (changed > 0)
+				attrstr = newstr_attrs(interface_cold->name, changed, &interface->attrs, &attrs, lladdr);
+			interface->attrs = attrs;
+
+			/* the link dump at startup just records interfaces that were
+			 * not known before, others are notified if they changed */
+			if (msg->nlmsg_flags & NLM_F_MULTI) {
+				interface->seen = SEEN_DUMP;
+
+				if (interface->state < 0 && resync_quiet > 0) {
+					interface->seen = SEEN_NEW;
+					interface->state = ifi->ifi_flags & CHECK_CONNECTED;
+					rc = EXIT_SUCCESS;
+					goto out;
+				}
+			}
 
 			icon = ifi->ifi_flags & CHECK_CONNECTED ? ICON_NETWORK_UP : ICON_NETWORK_DOWN;
 
-			/* free only if interface goes down */
+			/* state did not change, notify about attributes (if any) */
+			if ((ifi->ifi_flags & CHECK_CONNECTED) == interface->state) {
+				if (attrstr == NULL) {
+					rc = EXIT_SUCCESS;
+					goto out;
+				}
+
+				notifystr = attrstr;
+				attrstr = NULL;
+
+				break;
+			}
+
+			interface->state = ifi->ifi_flags & CHECK_CONNECTED;
+
+			notifystr = newstr_link(interface_cold->name, ifi->ifi_flags);
+
+			/* append attribute changes to state change */
+			if (attrstr != NULL) {
+				notifystr = realloc(notifystr, strlen(notifystr) + strlen(attrstr) + 2);
+				strcat(notifystr, "\n");
+				strcat(notifystr, attrstr);
+			}
+
+			/* mark only if interface goes down */
 			if (!(ifi->ifi_flags & CHECK_CONNECTED)) {
-				free_addresses(ifs[ifi->ifi_index].addresses_seen);
-				ifs[ifi->ifi_index].addresses_seen = NULL;
+				mark_addresses(addresses_seen);
+				if (resync == RESYNC_ADDR && ifi->ifi_index <= resync_max)
+					mark_addresses(&resync_addresses[ifi->ifi_index]);
 			}
 
 			break;
 		case RTM_DELLINK:
-			notifystr = newstr_away(ifs[ifi->ifi_index].name);
+			notifystr = newstr_away(interface_cold->name);
 
 			icon = ICON_NETWORK_AWAY;
 
-			free_addresses(ifs[ifi->ifi_index].addresses_seen);
+			free_addresses(addresses_seen);
+			if (resync == RESYNC_ADDR && ifi->ifi_index <= resync_max)
+				free_addresses(&resync_addresses[ifi->ifi_index]);
 			/* marking interface deleted makes events for this interface to be ignored */
-			ifs[ifi->ifi_index].deleted = 1;
+			interface->deleted = 1;
 
 			break;
 		default:
@@ -463,6 +1041,13 @@ int msg_handler (struct sockaddr_nl *nl, struct nlmsghdr *msg) {
 	if (verbose > 0)
 		printf("%s: %s (%s)\n", program, notifystr, icon);
 
+	/* link notification is created on first use */
+	if (notification == NULL) {
+		if (interface_cold->notification == NULL)
+			interface_cold->notification = new_notification();
+		notification = interface_cold->notification;
+	}
+
 	notify_notification_update(notification, TEXT_TOPIC, notifystr, icon);
 
 	if (notify_notification_show(notification, &error) == FALSE) {
@@ -478,12 +1063,19 @@ out:
 	if (addr_notification)
 		g_object_unref(G_OBJECT(addr_notification));
 	free(notifystr);
+	free(attrstr);
 
 	return rc;
 }
 
 /*** received_signal ***/
 void received_signal(int signal) {
+	/* the alarm is used to trigger periodic checkpoints */
+	if (signal == SIGALRM) {
+		docheckpoint++;
+		return;
+	}
+
 	if (verbose > 0)
 		printf("%s: Received signal: %s\n", program, strsignal(signal));
 
@@ -495,6 +1087,10 @@ int main (int argc, char **argv) {
 	int rc = EXIT_FAILURE;
 	int i, nls;
 	unsigned int version = 0, help = 0;
+	char *runtime_dir;
+	struct timespec start, ready;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
 
 	program = argv[0];
 
@@ -504,6 +1100,9 @@ int main (int argc, char **argv) {
 			case 'h':
 				help++;
 				break;
+			case 'r':
+				netlink_rcvbuf = atoi(optarg);
+				break;
 			case 't':
 				notification_timeout = atof(optarg) * 1000;
 				break;
@@ -525,7 +1124,7 @@ int main (int argc, char **argv) {
 			" (compiled: " __DATE__ ", " __TIME__ ")\n", program, PROGNAME, VERSION);
 
 	if (help > 0)
-		printf("usage: %s [-h] [-t TIMEOUT] [-v[v]] [-V]\n", program);
+		printf("usage: %s [-h] [-r RCVBUF] [-t TIMEOUT] [-v[v]] [-V]\n", program);
 
 	if (version > 0 || help > 0)
 		return EXIT_SUCCESS;
@@ -545,6 +1144,41 @@ int main (int argc, char **argv) {
 
 	sigaction(SIGINT, &act, NULL);
 	sigaction(SIGTERM, &act, NULL);
+	sigaction(SIGALRM, &act, NULL);
+
+	/* restore state from last run */
+	if ((runtime_dir = getenv("XDG_RUNTIME_DIR")) != NULL) {
+		checkpoint = malloc(strlen(runtime_dir) + sizeof(CHECKPOINT_FILE) + 1);
+		sprintf(checkpoint, "%s/" CHECKPOINT_FILE, runtime_dir);
+
+		read_checkpoint(checkpoint);
+
+		if (CHECKPOINT_INTERVAL > 0)
+			alarm(CHECKPOINT_INTERVAL);
+	} else if (verbose > 0)
+		printf("%s: XDG_RUNTIME_DIR is not set, checkpoints disabled.\n", program);
+
+	/* learn what is there, even without checkpoint - a resync after
+	 * lost events has to tell new interfaces from ones never seen
+	 * before. This reports what changed since the checkpoint, and
+	 * everything else stays quiet. */
+	start_resync(nls, 1);
+
+	/* handle the dumps before reporting ready */
+	while (resync != RESYNC_NONE && doexit == 0) {
+		if (read_event(nls) != EXIT_SUCCESS) {
+			fprintf(stderr, "%s: read_event returned error.\n", program);
+			goto out10;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ready);
+	if (verbose > 0) {
+		printf("%s: Ready after %.3f ms.\n", program,
+			(ready.tv_sec - start.tv_sec) * 1e3 + (ready.tv_nsec - start.tv_nsec) / 1e6);
+		/* make it visible when stdout is not a terminal */
+		fflush(stdout);
+	}
 
 #ifdef HAVE_SYSTEMD
 	sd_notify(0, "READY=1\nSTATUS=Waiting for netlink events...");
@@ -555,31 +1189,60 @@ int main (int argc, char **argv) {
 			fprintf(stderr, "%s: read_event returned error.\n", program);
 			goto out10;
 		}
+
+		/* a resync can not start while another one is running,
+		 * events lost meanwhile are caught by the next one */
+		if (doresync > 0 && resync == RESYNC_NONE) {
+			doresync = 0;
+			start_resync(nls, 0);
+		}
+
+		if (docheckpoint > 0) {
+			docheckpoint = 0;
+			write_checkpoint(checkpoint);
+			alarm(CHECKPOINT_INTERVAL);
+		}
 	}
 
 	if (verbose > 0)
 		printf("%s: Exiting...\n", program);
 
+	if (events_dropped > 0)
+		fprintf(stderr, "%s: Receive buffer overflowed %lu times, events were dropped.\n",
+				program, events_dropped);
+
 	/* report stopping to systemd */
 #ifdef HAVE_SYSTEMD
 	sd_notify(0, "STOPPING=1\nSTATUS=Stopping...");
 #endif
 
+	if (checkpoint != NULL)
+		write_checkpoint(checkpoint);
+
 	for(; maxinterface > 0; maxinterface--) {
 		if (verbose > 0)
 			printf("%s: Freeing interface %d: %s\n", program,
-					maxinterface, ifs[maxinterface].name);
+					maxinterface, ifs_cold[maxinterface].name);
 
-		free_addresses(ifs[maxinterface].addresses_seen);
-		if (ifs[maxinterface].notification != NULL)
-			g_object_unref(G_OBJECT(ifs[maxinterface].notification));
+		free_addresses(&ifs_addresses[maxinterface]);
+		if (ifs_cold[maxinterface].notification != NULL)
+			g_object_unref(G_OBJECT(ifs_cold[maxinterface].notification));
 	}
 
 	rc = EXIT_SUCCESS;
 
 out10:
+	if (resync_addresses != NULL) {
+		for (i = 1; i <= resync_max; i++)
+			free_addresses(&resync_addresses[i]);
+		free(resync_addresses);
+	}
 	if (ifs != NULL)
 		free(ifs);
+	if (ifs_addresses != NULL)
+		free(ifs_addresses);
+	if (ifs_cold != NULL)
+		free(ifs_cold);
 
 /* out20: */
 	notify_uninit();
@@ -589,6 +1252,8 @@ out30:
 		fprintf(stderr, "%s: Failed to close socket.\n", program);
 
 out40:
+	free(checkpoint);
+
 #ifdef HAVE_SYSTEMD
 	sd_notify(0, "STATUS=Stopped. Bye!");
 #endif
@@ -33,8 +33,12 @@
 #include <ifaddrs.h>
 #include <net/if.h>
 #include <netinet/in.h>
+#include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
 
 #include <linux/if.h>
 #include <linux/netlink.h>
@@ -55,47 +59,160 @@
 
 #define CHECK_CONNECTED	IFF_LOWER_UP
 
-struct addresses_seen {
-	char address[INET6_ADDRSTRLEN];
+/* link attributes to watch, see LINK_WATCH in config.h */
+#define LINK_WATCH_MTU		0x1
+#define LINK_WATCH_MASTER	0x2
+#define LINK_WATCH_OPERSTATE	0x4
+#define LINK_WATCH_LLADDR	0x8
+/* not configurable, renames are followed silently */
+#define LINK_IFNAME		0x10
+
+/* number of addresses stored inline, more go to heap */
+#define ADDRESSES_INLINE	4
+
+struct address {
+	unsigned char family;
 	unsigned char prefix;
-	struct addresses_seen *next;
+	unsigned char address[16];
+	/* link went down since notified, see mark_addresses() */
+	unsigned char stale;
 };
 
+struct addresses_seen {
+	unsigned int count;
+	unsigned int size;
+	struct address *overflow;
+	struct address local[ADDRESSES_INLINE];
+};
+
+/* fingerprint of watched link attributes, unwatched ones stay zero */
+struct link_attrs {
+	uint32_t mtu;
+	uint32_t master;
+	uint32_t lladdr;
+	uint32_t ifname;
+	uint8_t operstate;
+};
+
+/* state checked by every event, kept in a dense array,
+ * addresses_seen live in a parallel array */
 struct ifs {
-	char name[IF_NAMESIZE];
+	struct link_attrs attrs;
 	int state;
 	uint8_t deleted;
-	struct addresses_seen *addresses_seen;
+	uint8_t seen;
+};
+
+/* resync with the kernel: a link dump, followed by an address dump */
+#define RESYNC_NONE	0
+#define RESYNC_LINK	1
+#define RESYNC_ADDR	2
+
+/* values for seen, set from the link dump */
+#define SEEN_DUMP	1
+#define SEEN_NEW	2	/* not known before, recorded quietly at startup */
+
+/* data needed for notifications only */
+struct ifs_cold {
+	char name[IF_NAMESIZE];
 	NotifyNotification *notification;
 };
 
+/* checkpoint file: header, then per interface a record
+ * followed by its addresses */
+#define CHECKPOINT_MAGIC	0x4e4c4e32	/* NLN2 */
+#define CHECKPOINT_MAXINTERFACE	(1 << 20)
+
+struct checkpoint_header {
+	uint32_t magic;
+	uint16_t ifs_size;
+	uint16_t address_size;
+	uint32_t maxinterface;
+	uint32_t link_watch;	/* LINK_WATCH the attributes were saved with */
+};
+
+struct checkpoint_ifs {
+	char name[IF_NAMESIZE];
+	int32_t state;
+	uint32_t addresses;
+	uint8_t deleted;
+	struct link_attrs attrs;
+};
+
+/*** get_address ***/
+struct address * get_address(struct addresses_seen *addresses_seen, const unsigned int i);
+
+/*** fill_address ***/
+void fill_address(struct address *address, const struct ifaddrmsg *ifa, struct rtattr *rth);
+
+/*** same_address ***/
+int same_address(const struct address *a, const struct address *b);
+
 /*** free_addresses ***/
 void free_addresses(struct addresses_seen *addresses_seen);
 
 /*** add_address ***/
-struct addresses_seen * add_address(struct addresses_seen *addresses_seen, const char *address, const unsigned char prefix);
+void add_address(struct addresses_seen *addresses_seen, const struct address *address);
 
 /*** remove_address ***/
-struct addresses_seen * remove_address(struct addresses_seen *addresses_seen, const char *address, const unsigned char prefix);
+void remove_address(struct addresses_seen *addresses_seen, const struct address *address);
+
+/*** mark_addresses ***/
+void mark_addresses(struct addresses_seen *addresses_seen);
 
 /*** match_address ***/
-int match_address(struct addresses_seen *addresses_seen, const char *address, const unsigned char prefix);
+struct address * match_address(struct addresses_seen *addresses_seen, const struct address *address);
 
 /*** list_addresses ***/
 void list_addresses(struct addresses_seen *addresses_seen, const char *interface);
 
+/*** hash_data ***/
+uint32_t hash_data(const unsigned char *data, const unsigned int len);
+
+/*** get_link_attrs ***/
+void get_link_attrs(struct ifinfomsg *ifi, int rtl, struct link_attrs *attrs,
+		struct rtattr **lladdr, struct rtattr **ifname);
+
+/*** diff_link_attrs ***/
+unsigned int diff_link_attrs(const struct link_attrs *old, const struct link_attrs *new);
+
 /*** get_ssid ***/
 void get_ssid(const char *interface, char *essid);
 
+/*** new_notification ***/
+NotifyNotification * new_notification(void);
+
 /*** newstr_link ***/
 char * newstr_link(const char *interface, const unsigned int flags);
 
+/*** newstr_attrs ***/
+char * newstr_attrs(const char *interface, const unsigned int changed,
+		const struct link_attrs *old, const struct link_attrs *new, struct rtattr *lladdr);
+
 /*** newstr_addr ***/
 char * newstr_addr(const char *interface, const unsigned char family, const char *ipaddr, const unsigned char prefix);
 
 /*** newstr_away ***/
 char * newstr_away(const char *interface);
 
+/*** init_interfaces ***/
+void init_interfaces(const unsigned int index, const uint8_t lookup);
+
+/*** write_checkpoint ***/
+int write_checkpoint(const char *path);
+
+/*** read_checkpoint ***/
+int read_checkpoint(const char *path);
+
+/*** request_dump ***/
+int request_dump(int sock, const unsigned short type);
+
+/*** start_resync ***/
+int start_resync(int sock, const uint8_t quiet);
+
+/*** finish_resync ***/
+int finish_resync(int sock);
+
 /*** open_netlink ***/
 int open_netlink (void);
 
@@ -0,0 +1,147 @@
+/*
+ * (C) 2011-2026 by Christian Hesse <mail@eworm.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Benchmark of the msg_handler() hot path: unchanged RTM_NEWLINK messages
+ * (statistics updates) and RTM_NEWADDR for known addresses, spread over
+ * lots of interfaces. No notification is shown in the timed loop. */
+
+#define main netlink_notify_main
+#include "../netlink-notify.c"
+#undef main
+
+#include <time.h>
+
+#define BENCH_INTERFACES	50000
+#define BENCH_EVENTS		2000000
+
+struct bench_msg {
+	union {
+		struct nlmsghdr nlh;
+		char buf[512];
+	};
+};
+
+/*** add_attr ***/
+void add_attr(struct nlmsghdr *nlh, const unsigned short type, const void *data, const unsigned short len) {
+	struct rtattr *rta = (struct rtattr *) (((char *) nlh) + NLMSG_ALIGN(nlh->nlmsg_len));
+
+	rta->rta_type = type;
+	rta->rta_len = RTA_LENGTH(len);
+	memcpy(RTA_DATA(rta), data, len);
+	nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+}
+
+/*** build_link ***/
+void build_link(struct bench_msg *msg, const unsigned int index, const uint16_t flags) {
+	char name[IF_NAMESIZE];
+	uint32_t mtu = 1500;
+	uint8_t operstate = IF_OPER_UP;
+	unsigned char lladdr[6] = { 0x02, 0x00, index >> 24, index >> 16, index >> 8, index };
+	unsigned char stats[200];
+
+	struct ifinfomsg *ifi = NLMSG_DATA(&msg->nlh);
+
+	memset(msg, 0, sizeof(struct bench_msg));
+	msg->nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+	msg->nlh.nlmsg_type = RTM_NEWLINK;
+	msg->nlh.nlmsg_flags = flags;
+	ifi->ifi_index = index;
+	ifi->ifi_flags = IFF_UP | IFF_LOWER_UP;
+
+	snprintf(name, IF_NAMESIZE, "bench%u", index);
+	memset(stats, index, sizeof(stats));
+
+	add_attr(&msg->nlh, IFLA_IFNAME, name, strlen(name) + 1);
+	add_attr(&msg->nlh, IFLA_MTU, &mtu, sizeof(mtu));
+	add_attr(&msg->nlh, IFLA_OPERSTATE, &operstate, sizeof(operstate));
+	add_attr(&msg->nlh, IFLA_ADDRESS, lladdr, sizeof(lladdr));
+	add_attr(&msg->nlh, IFLA_STATS64, stats, sizeof(stats));
+}
+
+/*** build_addr ***/
+void build_addr(struct bench_msg *msg, const unsigned int index) {
+	unsigned char addr[4] = { 10, index >> 16, index >> 8, index };
+	struct ifaddrmsg *ifa = NLMSG_DATA(&msg->nlh);
+
+	memset(msg, 0, sizeof(struct bench_msg));
+	msg->nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifaddrmsg));
+	msg->nlh.nlmsg_type = RTM_NEWADDR;
+	ifa->ifa_family = AF_INET;
+	ifa->ifa_prefixlen = 8;
+	ifa->ifa_scope = RT_SCOPE_UNIVERSE;
+	ifa->ifa_index = index;
+
+	add_attr(&msg->nlh, IFA_ADDRESS, addr, sizeof(addr));
+	add_attr(&msg->nlh, IFA_LOCAL, addr, sizeof(addr));
+}
+
+/*** main ***/
+int main (int argc, char **argv) {
+	unsigned int interfaces = BENCH_INTERFACES, events = BENCH_EVENTS;
+	unsigned int i, index, seed = 1;
+	struct bench_msg msg, *links, *addrs;
+	struct address address;
+	struct ifaddrmsg *ifa;
+	struct timespec start, end;
+	double ns;
+
+	program = argv[0];
+
+	if (argc > 1)
+		interfaces = atoi(argv[1]);
+	if (argc > 2)
+		events = atoi(argv[2]);
+
+	links = malloc((interfaces + 1) * sizeof(struct bench_msg));
+	addrs = malloc((interfaces + 1) * sizeof(struct bench_msg));
+
+	/* messages from a link dump record interfaces without notification */
+	for (i = 1; i <= interfaces; i++) {
+		build_link(&msg, i, NLM_F_MULTI);
+		msg_handler(NULL, &msg.nlh);
+
+		build_link(&links[i], i, 0);
+		build_addr(&addrs[i], i);
+
+		/* every interface has one address known */
+		ifa = NLMSG_DATA(&addrs[i].nlh);
+		fill_address(&address, ifa, IFA_RTA(ifa));
+		add_address(&ifs_addresses[i], &address);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < events; i++) {
+		/* visit interfaces in random order */
+		seed = seed * 1103515245 + 12345;
+		index = seed % interfaces + 1;
+
+		if (i & 1)
+			msg_handler(NULL, &addrs[index].nlh);
+		else
+			msg_handler(NULL, &links[index].nlh);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+	printf("%s: %u interfaces, %u events: %.1f ns/event\n", program, interfaces, events, ns / events);
+
+	free(links);
+	free(addrs);
+
+	return EXIT_SUCCESS;
+}
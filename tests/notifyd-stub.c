@@ -0,0 +1,144 @@
+/*
+ * (C) 2011-2026 by Christian Hesse <mail@eworm.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Stub notification daemon for tests: owns org.freedesktop.Notifications
+ * on the session bus and prints one line per notification received,
+ * "<CLOCK_REALTIME in ns><tab><body>", with newlines in body replaced. */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <gio/gio.h>
+
+#define STUB_NAME	"org.freedesktop.Notifications"
+#define STUB_PATH	"/org/freedesktop/Notifications"
+
+const static gchar introspection_xml[] =
+	"<node>"
+	"  <interface name='" STUB_NAME "'>"
+	"    <method name='GetCapabilities'>"
+	"      <arg type='as' direction='out'/>"
+	"    </method>"
+	"    <method name='Notify'>"
+	"      <arg type='s' direction='in'/>"
+	"      <arg type='u' direction='in'/>"
+	"      <arg type='s' direction='in'/>"
+	"      <arg type='s' direction='in'/>"
+	"      <arg type='s' direction='in'/>"
+	"      <arg type='as' direction='in'/>"
+	"      <arg type='a{sv}' direction='in'/>"
+	"      <arg type='i' direction='in'/>"
+	"      <arg type='u' direction='out'/>"
+	"    </method>"
+	"    <method name='CloseNotification'>"
+	"      <arg type='u' direction='in'/>"
+	"    </method>"
+	"    <method name='GetServerInformation'>"
+	"      <arg type='s' direction='out'/>"
+	"      <arg type='s' direction='out'/>"
+	"      <arg type='s' direction='out'/>"
+	"      <arg type='s' direction='out'/>"
+	"    </method>"
+	"  </interface>"
+	"</node>";
+
+GDBusNodeInfo *introspection = NULL;
+guint32 last_id = 0;
+
+/*** method_call ***/
+void method_call(GDBusConnection *connection, const gchar *sender, const gchar *object_path,
+		const gchar *interface_name, const gchar *method_name, GVariant *parameters,
+		GDBusMethodInvocation *invocation, gpointer user_data) {
+	const gchar *capabilities[] = { "body", "body-markup", NULL };
+	const gchar *body;
+	gchar *line, *c;
+	guint32 id;
+	struct timespec now;
+
+	if (g_strcmp0(method_name, "Notify") == 0) {
+		clock_gettime(CLOCK_REALTIME, &now);
+
+		g_variant_get_child(parameters, 1, "u", &id);
+		g_variant_get_child(parameters, 4, "&s", &body);
+
+		line = g_strdup(body);
+		for (c = line; *c != '\0'; c++)
+			if (*c == '\n')
+				*c = ' ';
+		printf("%lld%09ld\t%s\n", (long long) now.tv_sec, now.tv_nsec, line);
+		g_free(line);
+
+		g_dbus_method_invocation_return_value(invocation,
+			g_variant_new("(u)", id > 0 ? id : ++last_id));
+	} else if (g_strcmp0(method_name, "GetCapabilities") == 0) {
+		g_dbus_method_invocation_return_value(invocation,
+			g_variant_new("(^as)", capabilities));
+	} else if (g_strcmp0(method_name, "GetServerInformation") == 0) {
+		g_dbus_method_invocation_return_value(invocation,
+			g_variant_new("(ssss)", "notifyd-stub", "netlink-notify", "0", "1.2"));
+	} else {
+		/* CloseNotification */
+		g_dbus_method_invocation_return_value(invocation, NULL);
+	}
+}
+
+const static GDBusInterfaceVTable vtable = { method_call, NULL, NULL };
+
+/*** bus_acquired ***/
+void bus_acquired(GDBusConnection *connection, const gchar *name, gpointer user_data) {
+	GError *error = NULL;
+
+	if (g_dbus_connection_register_object(connection, STUB_PATH, introspection->interfaces[0],
+			&vtable, NULL, NULL, &error) == 0) {
+		g_printerr("notifyd-stub: Failed to register object: %s\n", error->message);
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*** name_acquired ***/
+void name_acquired(GDBusConnection *connection, const gchar *name, gpointer user_data) {
+	/* the test waits for this line */
+	printf("# ready\n");
+}
+
+/*** name_lost ***/
+void name_lost(GDBusConnection *connection, const gchar *name, gpointer user_data) {
+	g_printerr("notifyd-stub: Failed to own name %s.\n", name);
+	exit(EXIT_FAILURE);
+}
+
+/*** main ***/
+int main (int argc, char **argv) {
+	GMainLoop *loop;
+
+	/* output is read while we are running */
+	setvbuf(stdout, NULL, _IOLBF, 0);
+
+	introspection = g_dbus_node_info_new_for_xml(introspection_xml, NULL);
+
+	g_bus_own_name(G_BUS_TYPE_SESSION, STUB_NAME, G_BUS_NAME_OWNER_FLAGS_NONE,
+		bus_acquired, name_acquired, name_lost, NULL, NULL);
+
+	loop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(loop);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,337 @@
+#!/bin/sh
+#
+# (C) 2011-2026 by Christian Hesse <mail@eworm.de>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Stress and latency test, run with 'make check'.
+#
+# This runs in private user and network namespaces (unshare -rn) with a
+# private session bus and a stub notification daemon, no real network or
+# desktop is touched. Lots of veth pairs are created, brought up, flapped,
+# addressed and destroyed in bulk, the daemon is restarted in between.
+# Finally the daemon runs with a tiny receive buffer, so events are lost
+# and the resync has to catch up. Notification texts are expected as in
+# config.def.h.
+#
+# Sizes and thresholds can be given in environment:
+#   PAIRS        veth pairs to create (default 1000, so 2000 interfaces)
+#   CHANGES      timed MTU changes for latency (default 500)
+#   MAX_P99      99th percentile latency in ms (default 50)
+#   MAX_DROPPED  events without notification (default 0)
+#   MAX_RSS      peak resident set size in KiB (default 65536)
+#   MAX_READY    restart to ready time in ms (default 20)
+#
+# MAX_READY is looser than the goal of well under 10 ms: with 2000
+# interfaces the kernel alone takes 5-10 ms for the link dump, and
+# restarts measure 10-15 ms. The goal is met with some hundred
+# interfaces (2-4 ms with 400), try PAIRS=200 MAX_READY=10.
+
+set -e
+
+: "${PAIRS:=1000}"
+: "${CHANGES:=500}"
+: "${MAX_P99:=50}"
+: "${MAX_DROPPED:=0}"
+: "${MAX_RSS:=65536}"
+: "${MAX_READY:=20}"
+
+cd "$(dirname "$0")/.."
+
+# run ourself in private namespaces
+if [ -z "${NETLINK_NOTIFY_NS}" ]; then
+	if ! unshare -rn true 2>/dev/null; then
+		echo "SKIP: Can not create user and network namespaces."
+		exit 0
+	fi
+	export NETLINK_NOTIFY_NS=1
+	exec unshare -rn "$0" "$@"
+fi
+
+if ! command -v dbus-daemon > /dev/null; then
+	echo "SKIP: dbus-daemon is not available."
+	exit 0
+fi
+
+if ! ip link add nn-test0 type veth peer name nn-test1 2>/dev/null; then
+	echo "SKIP: Can not create veth interfaces."
+	exit 0
+fi
+ip link del nn-test0
+
+TMP="$(mktemp -d)"
+DAEMON=
+STUB=
+BUS=
+
+cleanup() {
+	for PID in ${DAEMON} ${STUB} ${BUS}; do
+		kill "${PID}" 2>/dev/null || true
+	done
+	rm -rf "${TMP}"
+}
+trap cleanup EXIT
+
+# count notifications matching a pattern
+count() {
+	grep -c -- "$1" "${TMP}/notify.log" || true
+}
+
+# wait until no notification arrived for a second
+settle() {
+	LAST=-1
+	while [ "$(wc -l < "${TMP}/notify.log")" != "${LAST}" ]; do
+		LAST="$(wc -l < "${TMP}/notify.log")"
+		sleep 1
+	done
+}
+
+# wait for a line to show up in file
+wait_for() {
+	I=0
+	while ! grep -q -- "$2" "$1"; do
+		I=$((I + 1))
+		if [ ${I} -gt 100 ]; then
+			echo "FAIL: Timeout waiting for '$2' in $1."
+			cat "$1"
+			exit 1
+		fi
+		sleep 0.1
+	done
+}
+
+# peak resident set size of the daemon
+peak_rss() {
+	RSS="$(sed -n 's/^VmHWM:[[:space:]]*\([0-9]*\) kB/\1/p' "/proc/${DAEMON}/status")"
+	if [ "${RSS}" -gt "${PEAK_RSS}" ]; then
+		PEAK_RSS="${RSS}"
+	fi
+}
+
+start_daemon() {
+	: > "${TMP}/daemon.log"
+	XDG_RUNTIME_DIR="${TMP}" ./netlink-notify -v "$@" > "${TMP}/daemon.log" 2>&1 &
+	DAEMON=$!
+	wait_for "${TMP}/daemon.log" "Ready after"
+}
+
+stop_daemon() {
+	peak_rss
+	OVERFLOWS=$((OVERFLOWS + $(grep -c "Receive buffer overflow" "${TMP}/daemon.log" || true)))
+	kill -TERM "${DAEMON}"
+	wait "${DAEMON}" || true
+	DAEMON=
+}
+
+# restart, nothing is to be notified again
+restart() {
+	BEFORE="$(wc -l < "${TMP}/notify.log")"
+	stop_daemon
+	start_daemon
+	settle
+	GOT=$(($(wc -l < "${TMP}/notify.log") - BEFORE))
+	RENOTIFIED=$((RENOTIFIED + GOT))
+
+	# keep the slowest restart
+	TIME="$(sed -n 's/.*Ready after \([0-9.]*\) ms.*/\1/p' "${TMP}/daemon.log")"
+	if awk -v t="${TIME}" -v r="${READY}" 'BEGIN { exit !(t > r) }'; then
+		READY="${TIME}"
+	fi
+
+	printf "%-24s %6d expected, %6d notified\n" "$1:" 0 "${GOT}"
+}
+
+# print and account the result of a stage
+report() {
+	printf "%-24s %6d expected, %6d notified\n" "$1:" "$2" "$3"
+	if [ "$3" -lt "$2" ]; then
+		DROPPED=$((DROPPED + $2 - $3))
+	fi
+}
+
+# run a batch of ip commands and check for the expected number of
+# new notifications matching pattern
+stage() {
+	BEFORE="$(count "$2")"
+	ip -batch "${TMP}/batch"
+	settle
+	report "$1" "$3" $(($(count "$2") - BEFORE))
+}
+
+# private session bus with stub notification daemon
+cat > "${TMP}/bus.conf" <<EOF
+<busconfig>
+  <type>session</type>
+  <listen>unix:dir=${TMP}</listen>
+  <policy context="default">
+    <allow send_destination="*" eavesdrop="true"/>
+    <allow eavesdrop="true"/>
+    <allow own="*"/>
+  </policy>
+</busconfig>
+EOF
+dbus-daemon --config-file="${TMP}/bus.conf" --fork --nopidfile \
+	--print-address=1 --print-pid=1 > "${TMP}/bus"
+DBUS_SESSION_BUS_ADDRESS="$(sed -n 1p "${TMP}/bus")"
+BUS="$(sed -n 2p "${TMP}/bus")"
+export DBUS_SESSION_BUS_ADDRESS
+
+tests/notifyd-stub > "${TMP}/notify.log" &
+STUB=$!
+wait_for "${TMP}/notify.log" "# ready"
+
+DROPPED=0
+OVERFLOWS=0
+PEAK_RSS=0
+RENOTIFIED=0
+READY=0
+
+start_daemon
+
+# create, bring up and address interfaces in bulk
+for I in $(seq 1 "${PAIRS}"); do
+	echo "link add nn${I}a type veth peer name nn${I}b"
+done > "${TMP}/batch"
+stage "create interfaces" "Interface <b>nn[0-9]*[ab]</b> is <b>down</b>" $((PAIRS * 2))
+
+for I in $(seq 1 "${PAIRS}"); do
+	echo "link set nn${I}a up"
+	echo "link set nn${I}b up"
+done > "${TMP}/batch"
+stage "link up" "Interface <b>nn[0-9]*[ab]</b> is <b>up</b>" $((PAIRS * 2))
+
+for I in $(seq 1 "${PAIRS}"); do
+	echo "address add 10.$((I / 65536)).$((I / 256 % 256)).$((I % 256))/8 dev nn${I}a"
+done > "${TMP}/batch"
+stage "add addresses" "Interface <b>nn[0-9]*a</b> has new IP address" "${PAIRS}"
+
+# flap links, taking one end down takes carrier from the peer
+for I in $(seq 1 "${PAIRS}"); do
+	echo "link set nn${I}a down"
+done > "${TMP}/batch"
+stage "link down" "Interface <b>nn[0-9]*[ab]</b> is <b>down</b>" $((PAIRS * 2))
+
+for I in $(seq 1 "${PAIRS}"); do
+	echo "link set nn${I}a up"
+done > "${TMP}/batch"
+stage "link up again" "Interface <b>nn[0-9]*[ab]</b> is <b>up</b>" $((PAIRS * 2))
+
+# addresses survived the flap and were notified before
+restart "restart after flap"
+
+# remove and add addresses again, they have to be notified again
+for I in $(seq 1 "${PAIRS}"); do
+	echo "address del 10.$((I / 65536)).$((I / 256 % 256)).$((I % 256))/8 dev nn${I}a"
+done > "${TMP}/batch"
+stage "remove addresses" "has new IP address" 0
+
+sed -i 's/^address del/address add/' "${TMP}/batch"
+stage "add addresses again" "Interface <b>nn[0-9]*a</b> has new IP address" "${PAIRS}"
+
+# latency from a change to notification, one change at a time
+: > "${TMP}/sent"
+I=0
+while [ ${I} -lt "${CHANGES}" ]; do
+	N=$((I % PAIRS + 1))
+	MTU=$((1000 + I))
+	echo "$(date +%s%N) nn${N}a ${MTU}" >> "${TMP}/sent"
+	ip link set dev "nn${N}a" mtu "${MTU}"
+	I=$((I + 1))
+done
+settle
+
+# timestamps are in ns, compare the last 12 digits to stay within precision
+awk '
+	function ms(a, b) {
+		a = substr(a, length(a) - 11) + 0
+		b = substr(b, length(b) - 11) + 0
+		return (a < b ? a + 1e12 - b : a - b) / 1e6
+	}
+	FNR == NR { sent[$2 " " $3] = $1; next }
+	match($0, /Interface <b>[^<]*<\/b> has new MTU <b>[0-9]*<\/b>/) {
+		s = substr($0, RSTART, RLENGTH)
+		gsub(/<\/?b>/, "", s)
+		split(s, f, " ")
+		key = f[2] " " f[6]
+		if (key in sent) {
+			print ms($1, sent[key])
+			delete sent[key]
+		}
+	}' "${TMP}/sent" "${TMP}/notify.log" | sort -n > "${TMP}/latency"
+
+report "change mtu" "${CHANGES}" "$(wc -l < "${TMP}/latency")"
+
+set -- $(awk '
+	{ l[NR] = $1 }
+	function p(q, i) { i = int(q * NR); if (i < q * NR) i++; return i < 1 ? 0 : l[i] }
+	END { printf "%.3f %.3f %.3f %.3f\n", p(0.5), p(0.9), p(0.99), p(1) }' "${TMP}/latency")
+P50=$1 P90=$2 P99=$3 PMAX=$4
+
+restart "restart"
+
+# destroy, peers go away as well
+for I in $(seq 1 "${PAIRS}"); do
+	echo "link del nn${I}a"
+done > "${TMP}/batch"
+stage "destroy interfaces" "Interface <b>nn[0-9]*[ab]</b> has gone away" $((PAIRS * 2))
+
+# lose events: with a tiny receive buffer and the daemon stopped while
+# interfaces are created, the resync has to notify everything
+stop_daemon
+start_daemon -r 4096
+
+for I in $(seq 1 "${PAIRS}"); do
+	echo "link add nn${I}a type veth peer name nn${I}b"
+	echo "address add 10.$((I / 65536)).$((I / 256 % 256)).$((I % 256))/8 dev nn${I}a"
+done > "${TMP}/batch"
+LINKS="$(count "Interface <b>nn[0-9]*[ab]</b> is <b>down</b>")"
+ADDRESSES="$(count "Interface <b>nn[0-9]*a</b> has new IP address")"
+kill -STOP "${DAEMON}"
+ip -batch "${TMP}/batch"
+kill -CONT "${DAEMON}"
+settle
+report "create with overflow" $((PAIRS * 2)) \
+	$(($(count "Interface <b>nn[0-9]*[ab]</b> is <b>down</b>") - LINKS))
+report "addresses with overflow" "${PAIRS}" \
+	$(($(count "Interface <b>nn[0-9]*a</b> has new IP address") - ADDRESSES))
+LOST="$(grep -c "Receive buffer overflow" "${TMP}/daemon.log" || true)"
+
+stop_daemon
+
+echo
+echo "interfaces:        $((PAIRS * 2))"
+echo "latency (ms):      p50 ${P50}, p90 ${P90}, p99 ${P99}, max ${PMAX}"
+echo "dropped events:    ${DROPPED} (receive buffer overflows: ${OVERFLOWS})"
+echo "peak rss (KiB):    ${PEAK_RSS}"
+echo "restart to ready:  ${READY} ms"
+echo
+
+RC=0
+
+# fail if value exceeds maximum
+check() {
+	if awk -v v="$2" -v m="$3" 'BEGIN { exit !(v > m) }'; then
+		echo "FAIL: $1 is $2, maximum is $3."
+		RC=1
+	fi
+}
+
+check "p99 latency" "${P99}" "${MAX_P99}"
+check "dropped events" "${DROPPED}" "${MAX_DROPPED}"
+check "peak rss" "${PEAK_RSS}" "${MAX_RSS}"
+check "restart to ready" "${READY}" "${MAX_READY}"
+check "notifications on restart" "${RENOTIFIED}" 0
+
+if [ "${LOST}" -eq 0 ]; then
+	echo "FAIL: No receive buffer overflow, resync after lost events is not tested."
+	RC=1
+fi
+
+if [ ${RC} -eq 0 ]; then
+	echo "PASS"
+fi
+
+exit ${RC}